@@ -15,6 +15,368 @@
 #include <QJsonObject>
 #include <QMutex>
 #include <QMutexLocker>
+#include <QPainter>
+#include <QPixmap>
+#include <QElapsedTimer>
+#include <QVector>
+#include <QPaintEvent>
+#include <QResizeEvent>
+#include <QCommandLineParser>
+#include <QFile>
+#include <QHash>
+#include <QJsonArray>
+#include <QTextStream>
+#include <QtMath>
+#include <algorithm>
+#include <atomic>
+#include <cerrno>
+#include <cstdio>
+
+// ---------------- allocation counter (--bench) ----------------
+// Only built with DASHBOARD_BENCH (qmake DEFINES+=DASHBOARD_BENCH), so the
+// in-car binary keeps the plain libc allocator. On glibc the executable's
+// malloc family interposes libc's, so every heap allocation (Qt containers,
+// plain and aligned operator new) goes through here.
+static std::atomic<quint64> g_allocCount(0);
+
+#if defined(DASHBOARD_BENCH) && defined(__GLIBC__)
+static const bool kAllocCountAvailable = true;
+extern "C" {
+void *__libc_malloc(size_t size);
+void *__libc_calloc(size_t n, size_t size);
+void *__libc_realloc(void *ptr, size_t size);
+void *__libc_memalign(size_t alignment, size_t size);
+
+void *malloc(size_t size) noexcept
+{
+    g_allocCount.fetch_add(1, std::memory_order_relaxed);
+    return __libc_malloc(size);
+}
+
+void *calloc(size_t n, size_t size) noexcept
+{
+    g_allocCount.fetch_add(1, std::memory_order_relaxed);
+    return __libc_calloc(n, size);
+}
+
+void *realloc(void *ptr, size_t size) noexcept
+{
+    g_allocCount.fetch_add(1, std::memory_order_relaxed);
+    return __libc_realloc(ptr, size);
+}
+
+void *memalign(size_t alignment, size_t size) noexcept
+{
+    g_allocCount.fetch_add(1, std::memory_order_relaxed);
+    return __libc_memalign(alignment, size);
+}
+
+void *aligned_alloc(size_t alignment, size_t size) noexcept
+{
+    g_allocCount.fetch_add(1, std::memory_order_relaxed);
+    return __libc_memalign(alignment, size);
+}
+
+int posix_memalign(void **memptr, size_t alignment, size_t size) noexcept
+{
+    if (alignment % sizeof(void *) != 0 || (alignment & (alignment - 1)) != 0)
+        return EINVAL;
+    g_allocCount.fetch_add(1, std::memory_order_relaxed);
+    void *p = __libc_memalign(alignment, size);
+    if (!p) return ENOMEM;
+    *memptr = p;
+    return 0;
+}
+}
+#else
+static const bool kAllocCountAvailable = false;
+#endif
+
+// ---------------- TrendPlot ----------------
+// Scrolling sparkline backed by a fixed-capacity ring of samples. Each pixel
+// column is drawn as the min/max of the samples that fall into it, so the
+// drawing cost depends on the widget width, not on the number of samples.
+// The plot is cached in a pixmap: a new sample scrolls it and redraws only
+// the rightmost column(s). A value is held for at most two sample periods;
+// longer gaps (engine-off heartbeat, lost connection) are left empty.
+class TrendPlot : public QWidget
+{
+    Q_OBJECT
+
+public:
+    TrendPlot(const QString &color, double min, double max, int windowMs, int samplePeriodMs,
+              QWidget *parent = nullptr);
+
+    void addSample(double value);
+    void setRange(double min, double max);
+
+protected:
+    void paintEvent(QPaintEvent *event) override;
+    void resizeEvent(QResizeEvent *event) override;
+
+private slots:
+    void advance();
+
+private:
+    qint64 columnOf(qint64 t) const;
+    int holdColumns() const;
+    int yOf(double value) const;
+    void drawColumn(QPainter &p, int x, double lo, double hi);
+    void scrollTo(qint64 col);
+    void rebuild();
+
+    QColor m_color;
+    QColor m_background;
+    double m_min;
+    double m_max;
+    int m_windowMs;
+    int m_samplePeriodMs;
+
+    // ring buffer, stored as separate timestamp/value columns
+    QVector<qint64> m_t;
+    QVector<float> m_v;
+    int m_head;     // index of the oldest sample
+    int m_count;
+
+    QElapsedTimer m_clock;
+    QTimer m_gapTimer;
+    QPixmap m_cache;
+    bool m_havePlot;     // the column state below is valid
+    qint64 m_lastCol;    // absolute column drawn at x = width - 1
+    qint64 m_lastDataCol; // absolute column of the newest sample
+    double m_colMin;     // min/max of the samples in m_lastDataCol
+    double m_colMax;
+    double m_prevLast;   // value m_lastDataCol is joined to (keeps the trace continuous)
+    double m_lastValue;  // newest sample
+};
+
+TrendPlot::TrendPlot(const QString &color, double min, double max, int windowMs, int samplePeriodMs,
+                     QWidget *parent)
+    : QWidget(parent), m_color(color), m_background("#1f1f1f"), m_min(min), m_max(max),
+      m_windowMs(windowMs), m_samplePeriodMs(qMax(1, samplePeriodMs)),
+      m_t(windowMs / m_samplePeriodMs + 1), m_v(windowMs / m_samplePeriodMs + 1),
+      m_head(0), m_count(0), m_havePlot(false), m_lastCol(0), m_lastDataCol(0),
+      m_colMin(0), m_colMax(0), m_prevLast(0), m_lastValue(0)
+{
+    setAttribute(Qt::WA_OpaquePaintEvent);
+    // the plot only takes space left over by the layout (up to 40 px), so
+    // enabling trends never raises the 800x480 minimum
+    setSizePolicy(QSizePolicy::Expanding, QSizePolicy::Ignored);
+    setMinimumHeight(0);
+    setMaximumHeight(40);
+    m_clock.start();
+
+    // keeps the plot scrolling through gaps in the data
+    m_gapTimer.setTimerType(Qt::CoarseTimer);
+    connect(&m_gapTimer, &QTimer::timeout, this, &TrendPlot::advance);
+    m_gapTimer.start(2 * m_samplePeriodMs);
+}
+
+qint64 TrendPlot::columnOf(qint64 t) const
+{
+    return t * m_cache.width() / m_windowMs;
+}
+
+int TrendPlot::holdColumns() const
+{
+    qint64 cols = (2LL * m_samplePeriodMs * m_cache.width() + m_windowMs - 1) / m_windowMs;
+    return static_cast<int>(qMax<qint64>(1, cols));
+}
+
+int TrendPlot::yOf(double value) const
+{
+    int h = m_cache.height();
+    if (m_max <= m_min) return h - 1;
+    double f = (value - m_min) / (m_max - m_min);
+    if (f < 0.0) f = 0.0;
+    if (f > 1.0) f = 1.0;
+    return (h - 1) - static_cast<int>(f * (h - 1) + 0.5);
+}
+
+void TrendPlot::drawColumn(QPainter &p, int x, double lo, double hi)
+{
+    int yTop = yOf(hi);
+    int yBottom = yOf(lo);
+    p.fillRect(x, 0, 1, m_cache.height(), m_background);
+    p.fillRect(x, yTop, 1, yBottom - yTop + 1, m_color);
+}
+
+// move the right edge to 'col'; new columns hold the newest value while
+// within holdColumns() of it and are left empty after that
+void TrendPlot::scrollTo(qint64 col)
+{
+    int w = m_cache.width();
+    int shift = static_cast<int>(qMin<qint64>(col - m_lastCol, w));
+    if (shift <= 0) return;
+    if (shift < w)
+        m_cache.scroll(-shift, 0, m_cache.rect());
+    m_lastCol = col;
+
+    QPainter p(&m_cache);
+    int hold = holdColumns();
+    for (int x = w - shift; x < w; ++x) {
+        qint64 c = col - (w - 1 - x);
+        if (c - m_lastDataCol <= hold)
+            drawColumn(p, x, m_lastValue, m_lastValue);
+        else
+            p.fillRect(x, 0, 1, m_cache.height(), m_background);
+    }
+}
+
+void TrendPlot::addSample(double value)
+{
+    qint64 t = m_clock.elapsed();
+    int capacity = m_t.size();
+    int idx;
+    if (m_count < capacity) {
+        idx = (m_head + m_count) % capacity;
+        ++m_count;
+    } else {
+        idx = m_head;
+        m_head = (m_head + 1) % capacity;
+    }
+    m_t[idx] = t;
+    m_v[idx] = static_cast<float>(value);
+
+    if (m_cache.isNull()) return;
+
+    int w = m_cache.width();
+    qint64 col = columnOf(t);
+    if (!m_havePlot) {
+        m_havePlot = true;
+        m_lastCol = m_lastDataCol = col;
+        m_colMin = m_colMax = m_prevLast = m_lastValue = value;
+    } else if (col != m_lastDataCol) {
+        // first sample of a new column: join it to the previous one unless
+        // there was a gap
+        m_prevLast = col - m_lastDataCol <= holdColumns() ? m_lastValue : value;
+        m_colMin = m_colMax = value;
+    } else {
+        m_colMin = qMin(m_colMin, value);
+        m_colMax = qMax(m_colMax, value);
+    }
+
+    bool scrolled = col > m_lastCol;
+    if (scrolled) scrollTo(col);
+    m_lastDataCol = col;
+    m_lastValue = value;
+
+    int x = (w - 1) - static_cast<int>(m_lastCol - col);
+    if (x < 0) return;
+    QPainter p(&m_cache);
+    drawColumn(p, x, qMin(m_colMin, m_prevLast), qMax(m_colMax, m_prevLast));
+
+    if (scrolled)
+        update();
+    else
+        update(x, 0, 1, height());
+}
+
+// Scrolls the plot while no samples arrive, so it keeps showing the last
+// window; stops once the old data has scrolled out.
+void TrendPlot::advance()
+{
+    if (!m_havePlot || m_cache.isNull()) return;
+    int hold = holdColumns();
+    qint64 col = columnOf(m_clock.elapsed());
+    if (col - m_lastDataCol <= hold) return;                      // samples are arriving
+    if (m_lastCol - m_lastDataCol >= m_cache.width() + hold) return; // already empty
+    if (col > m_lastCol) {
+        scrollTo(col);
+        update();
+    }
+}
+
+void TrendPlot::setRange(double min, double max)
+{
+    m_min = min;
+    m_max = max;
+    rebuild();
+}
+
+void TrendPlot::rebuild()
+{
+    m_havePlot = false;
+    if (width() <= 0 || height() <= 0) {
+        m_cache = QPixmap();
+        return;
+    }
+    m_cache = QPixmap(size());
+    m_cache.fill(m_background);
+    update();
+    if (m_count == 0) return;
+
+    // full min/max decimation of the ring into one bucket per pixel column,
+    // with the right edge at the current time
+    int w = m_cache.width();
+    int hold = holdColumns();
+    int capacity = m_t.size();
+    int newest = (m_head + m_count - 1) % capacity;
+    m_lastDataCol = columnOf(m_t[newest]);
+    m_lastCol = qMax(m_lastDataCol, columnOf(m_clock.elapsed()));
+
+    QVector<float> lo(w), hi(w), last(w);
+    QVector<bool> has(w, false);
+    for (int k = 0; k < m_count; ++k) {
+        int idx = (m_head + k) % capacity;
+        qint64 x = (w - 1) - (m_lastCol - columnOf(m_t[idx]));
+        if (x < 0) continue;
+        float v = m_v[idx];
+        if (!has[x]) {
+            lo[x] = hi[x] = v;
+            has[x] = true;
+        } else {
+            lo[x] = qMin(lo[x], v);
+            hi[x] = qMax(hi[x], v);
+        }
+        last[x] = v;
+    }
+
+    int xNewest = (w - 1) - static_cast<int>(qMin<qint64>(m_lastCol - m_lastDataCol, w));
+    m_colMin = m_colMax = m_prevLast = m_lastValue = m_v[newest];
+
+    QPainter p(&m_cache);
+    bool havePrev = false;
+    int prevX = 0;
+    double prev = 0.0;
+    for (int x = 0; x < w; ++x) {
+        if (has[x]) {
+            double l = lo[x], h = hi[x];
+            bool joined = havePrev && x - prevX <= hold;
+            if (joined) {
+                l = qMin(l, prev);
+                h = qMax(h, prev);
+            }
+            drawColumn(p, x, l, h);
+            if (x == xNewest) {
+                m_colMin = lo[x];
+                m_colMax = hi[x];
+                m_prevLast = joined ? prev : last[x];
+            }
+            prev = last[x];
+            prevX = x;
+            havePrev = true;
+        } else if (havePrev && x - prevX <= hold) {
+            drawColumn(p, x, prev, prev);
+        }
+    }
+    m_havePlot = true;
+}
+
+void TrendPlot::paintEvent(QPaintEvent *event)
+{
+    QPainter p(this);
+    if (m_cache.isNull())
+        p.fillRect(event->rect(), m_background);
+    else
+        p.drawPixmap(event->rect(), m_cache, event->rect());
+}
+
+void TrendPlot::resizeEvent(QResizeEvent *event)
+{
+    QWidget::resizeEvent(event);
+    rebuild();
+}
 
 class SensorWidget : public QFrame
 {
@@ -26,17 +388,24 @@ public:
 
     void setValue(double value);
     void setRange(double min, double max);
+    // show a trend of the last 'seconds' below the bar (0 hides it);
+    // samplePeriodMs is the expected interval between addTrendSample() calls
+    void setTrendWindow(int seconds, int samplePeriodMs);
+    // record a real channel sample in the trend (not every rendered frame)
+    void addTrendSample(double value);
 
 private:
     QLabel *valueLabel;
     QProgressBar *progressBar;
+    TrendPlot *trendPlot;
+    QString m_color;
     double m_min;
     double m_max;
 };
 
 SensorWidget::SensorWidget(const QString &name, const QString &unit, const QString &color,
                            double min, double max, QWidget *parent)
-    : QFrame(parent), m_min(min), m_max(max)
+    : QFrame(parent), trendPlot(nullptr), m_color(color), m_min(min), m_max(max)
 {
     this->setFrameShape(QFrame::StyledPanel);
     this->setObjectName("sensorFrame");
@@ -78,6 +447,28 @@ void SensorWidget::setRange(double min, double max)
     m_min = min;
     m_max = max;
     progressBar->setRange(static_cast<int>(min*10), static_cast<int>(max*10));
+    if (trendPlot) trendPlot->setRange(min, max);
+}
+
+void SensorWidget::setTrendWindow(int seconds, int samplePeriodMs)
+{
+    if (trendPlot) {
+        layout()->removeWidget(trendPlot);
+        delete trendPlot;
+        trendPlot = nullptr;
+    }
+    if (seconds <= 0) return;
+
+    trendPlot = new TrendPlot(m_color, m_min, m_max, seconds * 1000, samplePeriodMs);
+    layout()->addWidget(trendPlot);
+}
+
+void SensorWidget::addTrendSample(double value)
+{
+    if (!trendPlot) return;
+    if (value < m_min) value = m_min;
+    if (value > m_max) value = m_max;
+    trendPlot->addSample(value);
 }
 
 void SensorWidget::setValue(double value)
@@ -89,12 +480,20 @@ void SensorWidget::setValue(double value)
 }
 
 // ---------------- Dashboard ----------------
+// The backend polls each PID roughly every 1.4 s while running (ble_stream.c
+// schedules); trend buffers are sized for one sample per second per channel.
+static const int kChannelSamplePeriodMs = 1000;
+
+// Activity states published by the backend as {"power": {"state": ...}}
+static const char *kPowerStateNames[] = { "running", "idling", "engine_off", "adapter_asleep" };
+
 class Dashboard : public QMainWindow
 {
     Q_OBJECT
 
 public:
-    Dashboard(QWidget *parent = nullptr);
+    // benchMode: no WebSocket and no frame timer; RenderBench drives the frames
+    Dashboard(QWidget *parent = nullptr, bool benchMode = false);
     ~Dashboard();
 
 private slots:
@@ -102,10 +501,15 @@ private slots:
     void onTextMessageReceived(const QString &message);
     void onWsConnected();
     void onWsDisconnected();
+    void reportPower();
 
 private:
+    enum PowerState { Running, Idling, EngineOff, AdapterAsleep, PowerStateCount };
+
     void setupUI();
     void applyStyles();
+    void setPowerState(PowerState state);
+    bool isLowPower() const { return m_powerState == EngineOff || m_powerState == AdapterAsleep; }
 
     QLabel *rpmCentralLabel;
     QProgressBar *rpmTopBar;
@@ -124,16 +528,42 @@ private:
     QMutex m_jsonMutex;
     QJsonObject m_lastJson;
     bool m_haveData;
+
+    // power management: with the engine off the frame timer stops and the
+    // UI is only updated when a message arrives
+    PowerState m_powerState;
+    qint64 m_stateTimeMs[PowerStateCount];
+    QElapsedTimer m_stateClock;     // time in the current state
+    QElapsedTimer m_reportClock;
+    int m_frames;                   // frames since the last report
+    bool m_renderQueued;
+
+    // last rendered values (rpm, speed, tps, map, battery, coolant) and rpm
+    // colour band, so unchanged frames skip the relabel and the restyle
+    double m_shown[6];
+    bool m_haveShown;
+    int m_rpmBand;      // 0 normal, 1 warning, 2 red; -1 before the first frame
+    QTimer *powerReportTimer;
+
+    friend class RenderBench;
 };
 
-Dashboard::Dashboard(QWidget *parent)
-    : QMainWindow(parent), m_ws(nullptr), m_haveData(false)
+Dashboard::Dashboard(QWidget *parent, bool benchMode)
+    : QMainWindow(parent), timer(nullptr), m_ws(nullptr), m_haveData(false),
+      m_powerState(Running), m_frames(0), m_renderQueued(false), powerReportTimer(nullptr),
+      m_haveShown(false), m_rpmBand(-1)
 {
+    for (int i = 0; i < PowerStateCount; ++i) m_stateTimeMs[i] = 0;
+    m_stateClock.start();
+    m_reportClock.start();
+
     setupUI();
     applyStyles();
 
     setMinimumSize(800, 480);
 
+    if (benchMode) return;
+
     m_ws = new QWebSocket();
     connect(m_ws, &QWebSocket::textMessageReceived, this, &Dashboard::onTextMessageReceived);
     connect(m_ws, &QWebSocket::connected, this, &Dashboard::onWsConnected);
@@ -144,6 +574,10 @@ Dashboard::Dashboard(QWidget *parent)
     timer = new QTimer(this);
     connect(timer, &QTimer::timeout, this, &Dashboard::updateData);
     timer->start(33);
+
+    powerReportTimer = new QTimer(this);
+    connect(powerReportTimer, &QTimer::timeout, this, &Dashboard::reportPower);
+    powerReportTimer->start(10000);
 }
 
 Dashboard::~Dashboard()
@@ -209,6 +643,9 @@ void Dashboard::setupUI()
     mapSensor = new SensorWidget("MAP", "kPa", "#f39c12", 0.0, 250.0);
     tpsSensor = new SensorWidget("TPS", "%", "#2ecc71", 0.0, 100.0);
     batterySensor = new SensorWidget("BATERIA", "V", "#f1c40f", 10.0, 16.0);
+    mapSensor->setTrendWindow(60, kChannelSamplePeriodMs);
+    tpsSensor->setTrendWindow(60, kChannelSamplePeriodMs);
+    batterySensor->setTrendWindow(60, kChannelSamplePeriodMs);
 
     QVBoxLayout *leftSensors = new QVBoxLayout();
     leftSensors->setSpacing(15);
@@ -218,6 +655,7 @@ void Dashboard::setupUI()
     mainLayout->addLayout(leftSensors, 1, 0);
 
     coolantSensor = new SensorWidget("COOLANT", "°C", "#9b59b6", -40.0, 215.0);
+    coolantSensor->setTrendWindow(60, kChannelSamplePeriodMs);
     QVBoxLayout *rightSensors = new QVBoxLayout();
     rightSensors->setSpacing(15);
     rightSensors->addWidget(coolantSensor);
@@ -302,19 +740,77 @@ void Dashboard::onTextMessageReceived(const QString &message)
 {
     QJsonParseError err;
     QJsonDocument doc = QJsonDocument::fromJson(message.toUtf8(), &err);
-    if (err.error == QJsonParseError::NoError && doc.isObject()) {
+    if (err.error != QJsonParseError::NoError || !doc.isObject()) return;
+
+    QJsonObject obj = doc.object();
+    if (obj.contains("power")) {
+        QString name = obj.value("power").toObject().value("state").toString();
+        for (int i = 0; i < PowerStateCount; ++i) {
+            if (name == QLatin1String(kPowerStateNames[i])) setPowerState(static_cast<PowerState>(i));
+        }
+        return;
+    }
+
+    {
         QMutexLocker locker(&m_jsonMutex);
-        m_lastJson = doc.object();
+        m_lastJson = obj;
         m_haveData = true;
     }
+
+    // trends get one point per channel sample, only for the keys in this message
+    if (obj.value("map").isDouble()) mapSensor->addTrendSample(obj.value("map").toDouble());
+    if (obj.value("tps").isDouble()) tpsSensor->addTrendSample(obj.value("tps").toDouble());
+    if (obj.value("battery").isDouble()) batterySensor->addTrendSample(obj.value("battery").toDouble());
+    if (obj.value("coolant").isDouble()) coolantSensor->addTrendSample(obj.value("coolant").toDouble());
+
+    if (isLowPower()) {
+        // wake on the first RPM or speed sample instead of waiting for the backend's state message
+        if (obj.value("rpm").toDouble() > 0 || obj.value("speed").toDouble() > 0) {
+            setPowerState(Running);
+        } else if (!m_renderQueued) {
+            m_renderQueued = true;
+            QTimer::singleShot(0, this, &Dashboard::updateData);
+        }
+    }
+}
+
+void Dashboard::setPowerState(PowerState state)
+{
+    if (state == m_powerState) return;
+    m_stateTimeMs[m_powerState] += m_stateClock.restart();
+    qInfo("Power state: %s -> %s", kPowerStateNames[m_powerState], kPowerStateNames[state]);
+    m_powerState = state;
+
+    if (!timer) return; // bench mode: frames are driven by RenderBench
+    if (isLowPower())
+        timer->stop();
+    else if (!timer->isActive())
+        timer->start(33);
+}
+
+void Dashboard::reportPower()
+{
+    double secs = m_reportClock.restart() / 1000.0;
+    double t[PowerStateCount];
+    for (int i = 0; i < PowerStateCount; ++i) t[i] = m_stateTimeMs[i] / 1000.0;
+    t[m_powerState] += m_stateClock.elapsed() / 1000.0;
+
+    qInfo("Power: state=%s frames=%.1f/s time running=%.0fs idling=%.0fs engine_off=%.0fs adapter_asleep=%.0fs",
+          kPowerStateNames[m_powerState], secs > 0 ? m_frames / secs : 0.0,
+          t[Running], t[Idling], t[EngineOff], t[AdapterAsleep]);
+    m_frames = 0;
 }
 
 void Dashboard::updateData()
 {
+    m_renderQueued = false;
+
     QJsonObject obj;
     {
         QMutexLocker locker(&m_jsonMutex);
         if (!m_haveData) {
+            ++m_frames;
+            m_haveShown = false;
             rpmTopBar->setValue(0);
             rpmCentralLabel->setText("0");
             speedLabel->setText("0");
@@ -341,6 +837,13 @@ void Dashboard::updateData()
     if (obj.contains("battery") && obj.value("battery").isDouble()) battery = obj.value("battery").toDouble();
     if (obj.contains("coolant") && obj.value("coolant").isDouble()) coolant = obj.value("coolant").toDouble();
 
+    // nothing changed since the last frame (e.g. engine-off heartbeats): skip
+    const double shown[6] = { rpm, speed, tps, map, battery, coolant };
+    if (m_haveShown && std::equal(shown, shown + 6, m_shown)) return;
+    std::copy(shown, shown + 6, m_shown);
+    m_haveShown = true;
+    ++m_frames;
+
     rpmTopBar->setValue(static_cast<int>(rpm));
     rpmCentralLabel->setText(QString::number(static_cast<int>(rpm)));
     speedLabel->setText(QString::number(static_cast<int>(speed)));
@@ -350,10 +853,16 @@ void Dashboard::updateData()
     batterySensor->setValue(battery);
     coolantSensor->setValue(coolant);
 
-    if (rpm > 6000) {
+    // setStyleSheet re-polishes and repaints even with the same sheet, so
+    // only restyle when the band changes
+    int band = rpm > 6000 ? 2 : (rpm > 5500 ? 1 : 0);
+    if (band == m_rpmBand) return;
+    m_rpmBand = band;
+
+    if (band == 2) {
         rpmCentralLabel->setStyleSheet("color: #ff3838;");
         rpmTopBar->setStyleSheet("QProgressBar#rpmTopBar::chunk { background-color: #ff3838; }");
-    } else if (rpm > 5500) {
+    } else if (band == 1) {
         rpmCentralLabel->setStyleSheet("color: #f1c40f;");
         rpmTopBar->setStyleSheet("QProgressBar#rpmTopBar::chunk { background-color: #f1c40f; }");
     } else {
@@ -362,12 +871,310 @@ void Dashboard::updateData()
     }
 }
 
+// ---------------- RenderBench ----------------
+// Headless benchmark (--bench): feeds Dashboard a synthetic or recorded
+// telemetry stream and measures each frame. Output is one JSON object per
+// line on stdout: one per frame, then a final {"summary": ...}.
+class RenderBench : public QObject
+{
+    Q_OBJECT
+
+public:
+    RenderBench(Dashboard *dash, int frames, int fps, int rateHz, const QStringList &replay,
+                QObject *parent = nullptr);
+
+    void start();
+    void recordPaint(QObject *receiver, qint64 ns);
+
+private slots:
+    void onFeed();
+    void onFrame();
+
+private:
+    struct Stats {
+        QVector<double> values;
+        QJsonObject toJson() const;
+    };
+
+    QString nextMessage();
+    void finish();
+
+    Dashboard *m_dash;
+    QTimer m_feedTimer;
+    QTimer m_frameTimer;
+    int m_frames;
+    int m_fps;
+    int m_rateHz;
+    QStringList m_replay;
+    QStringList m_queued;   // messages fed since the last frame, delivered inside it
+    int m_feedCount;
+    int m_frame;
+    bool m_inFrame;
+    QElapsedTimer m_wall;
+
+    // widgets are named once up front so recording a paint never allocates
+    QHash<QObject *, int> m_widgetIds;
+    QStringList m_widgetNames;
+    QVector<qint64> m_framePaintNs;
+    QVector<Stats> m_widgetPaint;
+
+    Stats m_messagesUs;
+    Stats m_updateUs;
+    Stats m_paintUs;
+    Stats m_allocs;
+    QTextStream m_out;
+};
+
+QJsonObject RenderBench::Stats::toJson() const
+{
+    QJsonObject o;
+    if (values.isEmpty()) return o;
+    QVector<double> sorted = values;
+    std::sort(sorted.begin(), sorted.end());
+    double sum = 0.0;
+    for (double v : sorted) sum += v;
+    int n = static_cast<int>(sorted.size());
+    o["avg"] = sum / n;
+    o["p50"] = sorted[n / 2];
+    o["p95"] = sorted[qMin(n - 1, static_cast<int>(n * 0.95))];
+    o["max"] = sorted.last();
+    o["count"] = n;
+    return o;
+}
+
+RenderBench::RenderBench(Dashboard *dash, int frames, int fps, int rateHz,
+                         const QStringList &replay, QObject *parent)
+    : QObject(parent), m_dash(dash), m_frames(frames), m_fps(fps), m_rateHz(rateHz),
+      m_replay(replay), m_feedCount(0), m_frame(0), m_inFrame(false), m_out(stdout)
+{
+    connect(&m_feedTimer, &QTimer::timeout, this, &RenderBench::onFeed);
+    connect(&m_frameTimer, &QTimer::timeout, this, &RenderBench::onFrame);
+    m_feedTimer.setTimerType(Qt::PreciseTimer);
+    m_frameTimer.setTimerType(Qt::PreciseTimer);
+}
+
+void RenderBench::start()
+{
+    const QList<QWidget *> widgets = m_dash->findChildren<QWidget *>();
+    QHash<QString, int> seen;
+    for (QWidget *w : widgets) {
+        QString base = w->objectName().isEmpty() ? QString(w->metaObject()->className())
+                                                 : w->objectName();
+        int n = ++seen[base];
+        m_widgetIds.insert(w, m_widgetNames.size());
+        m_widgetNames << (n == 1 ? base : QString("%1#%2").arg(base).arg(n));
+    }
+    m_widgetIds.insert(m_dash, m_widgetNames.size());
+    m_widgetNames << "Dashboard";
+    m_framePaintNs.fill(0, m_widgetNames.size());
+    m_widgetPaint.resize(m_widgetNames.size());
+
+    m_wall.start();
+    if (m_rateHz > 0) m_feedTimer.start(1000 / m_rateHz);
+    // fps 0: render frames back to back
+    m_frameTimer.start(m_fps > 0 ? 1000 / m_fps : 0);
+}
+
+void RenderBench::recordPaint(QObject *receiver, qint64 ns)
+{
+    if (!m_inFrame) return;
+    auto it = m_widgetIds.constFind(receiver);
+    if (it != m_widgetIds.constEnd()) m_framePaintNs[it.value()] += ns;
+}
+
+// Scripted stream: one key per message, in the backend's PID order, with
+// values sweeping through the RPM warning thresholds.
+QString RenderBench::nextMessage()
+{
+    int k = m_feedCount++;
+    if (!m_replay.isEmpty()) return m_replay.at(k % m_replay.size());
+
+    double s = m_rateHz > 0 ? static_cast<double>(k) / m_rateHz : 0.0;
+    QJsonObject obj;
+    switch (k % 6) {
+    case 0: obj["rpm"] = static_cast<int>(800 + 3100 * (1 - qCos(2 * M_PI * s / 10))); break;
+    case 1: obj["speed"] = static_cast<int>(60 + 50 * qSin(2 * M_PI * s / 20)); break;
+    case 2: obj["tps"] = 50 + 50 * qSin(2 * M_PI * s / 4); break;
+    case 3: obj["map"] = static_cast<int>(100 + 80 * qSin(2 * M_PI * s / 4)); break;
+    case 4: obj["coolant"] = 90; break;
+    default: obj["battery"] = 13.8 + 0.3 * qSin(2 * M_PI * s / 30); break;
+    }
+    return QString::fromUtf8(QJsonDocument(obj).toJson(QJsonDocument::Compact));
+}
+
+// Messages are only queued here and handed to Dashboard at the start of the
+// next frame, so their cost (trend drawing, the repaints they schedule) is
+// measured with that frame.
+void RenderBench::onFeed()
+{
+    m_queued << nextMessage();
+}
+
+void RenderBench::onFrame()
+{
+    m_framePaintNs.fill(0);
+    quint64 allocs0 = g_allocCount.load(std::memory_order_relaxed);
+    m_inFrame = true;
+
+    QElapsedTimer t;
+    t.start();
+    int messages = m_queued.size();
+    for (const QString &msg : qAsConst(m_queued))
+        m_dash->onTextMessageReceived(msg);
+    m_queued.clear();
+    qint64 messagesNs = t.nsecsElapsed();
+
+    t.restart();
+    m_dash->updateData();
+    qint64 updateNs = t.nsecsElapsed();
+    // deliver everything this frame posted (polish, LayoutRequest from setText
+    // and setStyleSheet, UpdateRequest) synchronously, so relayouts and the
+    // repaints they trigger are counted in this frame; events posted while
+    // delivering are drained by the same call
+    QCoreApplication::sendPostedEvents();
+
+    m_inFrame = false;
+    quint64 allocs = g_allocCount.load(std::memory_order_relaxed) - allocs0;
+
+    qint64 paintNs = 0;
+    QJsonObject widgets;
+    for (int i = 0; i < m_framePaintNs.size(); ++i) {
+        if (m_framePaintNs[i] == 0) continue;
+        double us = m_framePaintNs[i] / 1000.0;
+        widgets[m_widgetNames[i]] = us;
+        m_widgetPaint[i].values << us;
+        paintNs += m_framePaintNs[i];
+    }
+    m_messagesUs.values << messagesNs / 1000.0;
+    m_updateUs.values << updateNs / 1000.0;
+    m_paintUs.values << paintNs / 1000.0;
+
+    QJsonObject line;
+    line["frame"] = m_frame;
+    line["messages"] = messages;
+    line["messages_us"] = messagesNs / 1000.0;
+    line["update_us"] = updateNs / 1000.0;
+    line["paint_us"] = paintNs / 1000.0;
+    if (kAllocCountAvailable) {
+        line["allocs"] = static_cast<double>(allocs);
+        m_allocs.values << static_cast<double>(allocs);
+    }
+    line["paint"] = widgets;
+    m_out << QJsonDocument(line).toJson(QJsonDocument::Compact) << '\n';
+
+    if (++m_frame >= m_frames) finish();
+}
+
+void RenderBench::finish()
+{
+    m_feedTimer.stop();
+    m_frameTimer.stop();
+    double wallMs = m_wall.nsecsElapsed() / 1.0e6;
+
+    QJsonObject widgets;
+    for (int i = 0; i < m_widgetNames.size(); ++i) {
+        if (!m_widgetPaint[i].values.isEmpty())
+            widgets[m_widgetNames[i]] = m_widgetPaint[i].toJson();
+    }
+
+    QJsonObject summary;
+    summary["frames"] = m_frame;
+    summary["wall_ms"] = wallMs;
+    summary["fps"] = wallMs > 0 ? m_frame * 1000.0 / wallMs : 0.0;
+    summary["target_fps"] = m_fps;
+    summary["rate_hz"] = m_rateHz;
+    summary["messages"] = m_feedCount;
+    summary["messages_us"] = m_messagesUs.toJson();
+    summary["update_us"] = m_updateUs.toJson();
+    summary["paint_us"] = m_paintUs.toJson();
+    if (kAllocCountAvailable) summary["allocs"] = m_allocs.toJson();
+    summary["widgets"] = widgets;
+
+    QJsonObject root;
+    root["summary"] = summary;
+    m_out << QJsonDocument(root).toJson(QJsonDocument::Compact) << '\n';
+    m_out.flush();
+    QCoreApplication::quit();
+}
+
+// QApplication that times paint events for RenderBench
+class BenchApplication : public QApplication
+{
+public:
+    BenchApplication(int &argc, char **argv) : QApplication(argc, argv), bench(nullptr) {}
+
+    bool notify(QObject *receiver, QEvent *event) override
+    {
+        if (!bench || event->type() != QEvent::Paint)
+            return QApplication::notify(receiver, event);
+        QElapsedTimer t;
+        t.start();
+        bool ret = QApplication::notify(receiver, event);
+        bench->recordPaint(receiver, t.nsecsElapsed());
+        return ret;
+    }
+
+    RenderBench *bench;
+};
+
 int main(int argc, char *argv[])
 {
-    QApplication app(argc, argv);
-    Dashboard window;
-    window.showFullScreen();
-    return app.exec();
+    // the platform plugin must be chosen before the application is created
+    for (int i = 1; i < argc; ++i) {
+        if (qstrcmp(argv[i], "--bench") == 0)
+            qputenv("QT_QPA_PLATFORM", "offscreen");
+    }
+
+    BenchApplication app(argc, argv);
+
+    QCommandLineParser parser;
+    parser.addHelpOption();
+    QCommandLineOption benchOpt("bench", "Headless render benchmark (offscreen, no backend), JSON lines on stdout.");
+    QCommandLineOption framesOpt("frames", "Frames to render in --bench (default 600).", "n", "600");
+    QCommandLineOption fpsOpt("fps", "Frame rate in --bench, 0 = as fast as possible (default 30).", "fps", "30");
+    QCommandLineOption rateOpt("rate", "Telemetry messages per second in --bench (default 30).", "hz", "30");
+    QCommandLineOption replayOpt("replay", "Replay a recorded stream in --bench: one JSON message per line.", "file");
+    QCommandLineOption sizeOpt("size", "Window size in --bench (default 800x480).", "WxH", "800x480");
+    parser.addOptions({ benchOpt, framesOpt, fpsOpt, rateOpt, replayOpt, sizeOpt });
+    parser.process(app);
+
+    if (!parser.isSet(benchOpt)) {
+        Dashboard window;
+        window.showFullScreen();
+        return app.exec();
+    }
+
+    QStringList replay;
+    if (parser.isSet(replayOpt)) {
+        QFile f(parser.value(replayOpt));
+        if (!f.open(QIODevice::ReadOnly | QIODevice::Text)) {
+            fprintf(stderr, "Cannot open %s\n", qPrintable(parser.value(replayOpt)));
+            return 1;
+        }
+        while (!f.atEnd()) {
+            QString line = QString::fromUtf8(f.readLine()).trimmed();
+            if (!line.isEmpty()) replay << line;
+        }
+    }
+
+    QStringList size = parser.value(sizeOpt).split('x');
+    int w = size.value(0).toInt();
+    int h = size.value(1).toInt();
+
+    Dashboard window(nullptr, true);
+    if (w > 0 && h > 0) window.resize(w, h);
+    window.show();
+
+    RenderBench bench(&window, qMax(1, parser.value(framesOpt).toInt()),
+                      qMax(0, parser.value(fpsOpt).toInt()),
+                      qMax(0, parser.value(rateOpt).toInt()), replay);
+    app.bench = &bench;
+    // let the first full paint happen before measuring
+    QCoreApplication::processEvents();
+    bench.start();
+    int rc = app.exec();
+    app.bench = nullptr;
+    return rc;
 }
 
 #include "main.moc"
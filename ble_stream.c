@@ -10,10 +10,25 @@
 #include <unistd.h>
 #include <signal.h>
 #include <pthread.h>
+#include <stdint.h>
+#include <time.h>
 #include <libwebsockets.h>
 
 #define WS_PORT 9090
 
+// History store: per-channel ring of (delta timestamp, value) columns.
+// 16384 samples * 8 bytes * 6 channels ~= 768 KB, which covers several hours
+// at the current poll rate (one sample per channel every ~1.4 s).
+#define HISTORY_CAPACITY 16384
+#define HISTORY_TICK_MS 10           // timestamp resolution (10 ms -> max delta ~497 days)
+#define HISTORY_DEFAULT_SPAN_MS 600000
+#define HISTORY_DEFAULT_POINTS 300
+#define HISTORY_MAX_POINTS 2000
+
+// Power management: no OBD response for this long -> adapter considered asleep
+#define ASLEEP_TIMEOUT_MS 10000
+#define POWER_REPORT_MS 10000
+
 // Handles (conforme informado)
 #define NOTIFY_VALUE_HANDLE "0x0015" // descriptor to enable notify
 #define WRITE_HANDLE "0x0017"        // handle to write commands
@@ -28,6 +43,131 @@ static char pending_msg[512];
 static int pending_flag = 0;
 static pthread_mutex_t pending_mutex = PTHREAD_MUTEX_INITIALIZER;
 
+// Pending power-state message (separate slot so PID updates don't overwrite it)
+static char pending_power_msg[512];
+static int pending_power_flag = 0;
+
+// ---------------- history store ----------------
+enum history_channel_id { CH_RPM, CH_SPEED, CH_TPS, CH_MAP, CH_COOLANT, CH_BATTERY, N_CHANNELS };
+
+// names match the JSON keys published over the WebSocket
+static const char *channel_names[N_CHANNELS] = { "rpm", "speed", "tps", "map", "coolant", "battery" };
+
+// Columnar ring: timestamps are stored as deltas (in ticks) to the previous
+// sample, so only the oldest and newest absolute timestamps are kept.
+struct history_channel {
+    uint64_t first_tick;  // absolute timestamp of the oldest sample
+    uint64_t last_tick;   // absolute timestamp of the newest sample
+    size_t head;          // index of the oldest sample
+    size_t count;
+    uint32_t dt[HISTORY_CAPACITY];   // delta to previous sample (unused for the oldest)
+    float value[HISTORY_CAPACITY];
+};
+
+static struct history_channel history[N_CHANNELS];
+static pthread_mutex_t history_mutex = PTHREAD_MUTEX_INITIALIZER;
+
+static uint64_t now_ms(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_REALTIME, &ts);
+    return (uint64_t)ts.tv_sec * 1000ULL + (uint64_t)ts.tv_nsec / 1000000ULL;
+}
+
+// append a sample; the oldest one is dropped when the ring is full
+static void history_push(int ch, uint64_t t_ms, double value) {
+    struct history_channel *h = &history[ch];
+    uint64_t tick = t_ms / HISTORY_TICK_MS;
+
+    pthread_mutex_lock(&history_mutex);
+    if (h->count == 0) {
+        h->first_tick = h->last_tick = tick;
+        h->head = 0;
+        h->dt[0] = 0;
+        h->value[0] = (float)value;
+        h->count = 1;
+        pthread_mutex_unlock(&history_mutex);
+        return;
+    }
+
+    // 32-bit deltas keep long gaps (engine off for hours) exact
+    uint64_t delta = tick > h->last_tick ? tick - h->last_tick : 0;
+    if (delta > UINT32_MAX) delta = UINT32_MAX;
+
+    if (h->count == HISTORY_CAPACITY) {
+        size_t next = (h->head + 1) % HISTORY_CAPACITY;
+        h->first_tick += h->dt[next];
+        h->head = next;
+        h->count--;
+    }
+    size_t idx = (h->head + h->count) % HISTORY_CAPACITY;
+    h->dt[idx] = (uint32_t)delta;
+    h->value[idx] = (float)value;
+    h->last_tick += delta;
+    h->count++;
+    pthread_mutex_unlock(&history_mutex);
+}
+
+static int history_channel_by_name(const char *name) {
+    for (int i = 0; i < N_CHANNELS; ++i)
+        if (strcmp(channel_names[i], name) == 0) return i;
+    return -1;
+}
+
+// Downsample [from_ms, to_ms] of a channel into 'points' equal-width buckets
+// and write them as JSON: {"channel":..,"from":..,"to":..,"points":[[t,min,max,avg,n],..]}.
+// Empty buckets are omitted. Returns the body length, or -1 if out is too small.
+static int history_query_json(int ch, uint64_t from_ms, uint64_t to_ms, int points,
+                              char *out, size_t out_len) {
+    double bmin[HISTORY_MAX_POINTS], bmax[HISTORY_MAX_POINTS], bsum[HISTORY_MAX_POINTS];
+    unsigned int bn[HISTORY_MAX_POINTS];
+    memset(bn, 0, sizeof(bn[0]) * points);
+
+    uint64_t span = to_ms > from_ms ? to_ms - from_ms : 1;
+    struct history_channel *h = &history[ch];
+
+    pthread_mutex_lock(&history_mutex);
+    uint64_t tick = h->first_tick;
+    for (size_t k = 0; k < h->count; ++k) {
+        size_t idx = (h->head + k) % HISTORY_CAPACITY;
+        if (k > 0) tick += h->dt[idx];
+        uint64_t t = tick * HISTORY_TICK_MS;
+        if (t < from_ms) continue;
+        if (t > to_ms) break;
+        int b = (int)((t - from_ms) * (uint64_t)points / span);
+        if (b >= points) b = points - 1;   // t == to_ms lands in the last bucket
+        double v = h->value[idx];
+        if (bn[b] == 0) {
+            bmin[b] = bmax[b] = bsum[b] = v;
+        } else {
+            if (v < bmin[b]) bmin[b] = v;
+            if (v > bmax[b]) bmax[b] = v;
+            bsum[b] += v;
+        }
+        bn[b]++;
+    }
+    pthread_mutex_unlock(&history_mutex);
+
+    size_t p = 0;
+    int n = snprintf(out, out_len, "{\"channel\": \"%s\", \"from\": %llu, \"to\": %llu, \"points\": [",
+                     channel_names[ch], (unsigned long long)from_ms, (unsigned long long)to_ms);
+    if (n < 0 || (size_t)n >= out_len) return -1;
+    p += n;
+    int first = 1;
+    for (int b = 0; b < points; ++b) {
+        if (bn[b] == 0) continue;
+        uint64_t t = from_ms + span * (uint64_t)b / (uint64_t)points;
+        n = snprintf(out + p, out_len - p, "%s[%llu, %.3f, %.3f, %.3f, %u]",
+                     first ? "" : ", ", (unsigned long long)t,
+                     bmin[b], bmax[b], bsum[b] / bn[b], bn[b]);
+        if (n < 0 || (size_t)n >= out_len - p) return -1;
+        p += n;
+        first = 0;
+    }
+    n = snprintf(out + p, out_len - p, "]}");
+    if (n < 0 || (size_t)n >= out_len - p) return -1;
+    return (int)(p + n);
+}
+
 // MAC address from argv
 static char ble_mac[64];
 
@@ -35,6 +175,126 @@ static char ble_mac[64];
 static const char *pids[] = { "010C", "010D", "0111", "010B", "0105", "0142" };
 static const int n_pids = sizeof(pids) / sizeof(pids[0]);
 
+// ---------------- power management ----------------
+// Activity state shared with the Dashboard (published as {"power": {...}}).
+// It selects the poll schedule: with the engine off (rpm 0 and speed 0) only
+// RPM and speed are polled as a slow heartbeat, and the first RPM > 0 or
+// speed > 0 switches back to the full schedule.
+enum activity_state { ST_RUNNING, ST_IDLING, ST_ENGINE_OFF, ST_ADAPTER_ASLEEP, N_STATES };
+
+static const char *state_names[N_STATES] = { "running", "idling", "engine_off", "adapter_asleep" };
+
+struct poll_schedule {
+    int cmd_gap_ms;     // pause after each command
+    int cycle_gap_ms;   // additional pause after each cycle
+    int n_polled;       // 0: all PIDs; else only the first n (pids[0..1] = RPM, speed)
+};
+
+static const struct poll_schedule schedules[N_STATES] = {
+    { 200, 200, 0 },     // running: all PIDs, ~1.4 s per cycle
+    { 200, 600, 0 },     // idling: all PIDs, slower cycle
+    { 200, 2000, 2 },    // engine off: RPM + speed heartbeat every ~2.4 s
+    { 200, 5000, 2 },    // adapter asleep: RPM + speed heartbeat every ~5.4 s
+};
+
+static pthread_mutex_t power_mutex = PTHREAD_MUTEX_INITIALIZER;
+static pthread_cond_t power_cond = PTHREAD_COND_INITIALIZER;
+static int power_state = ST_RUNNING;
+static uint64_t state_since_ms;
+static uint64_t state_time_ms[N_STATES];
+static int last_rpm = -1;           // -1: unknown
+static int last_speed = -1;
+static uint64_t last_response_ms;
+static unsigned long polls_sent;
+
+// publish the current state with time spent in each state and the poll rate
+// (caller holds power_mutex)
+static void power_publish_locked(uint64_t now, double poll_hz) {
+    double t[N_STATES];
+    for (int i = 0; i < N_STATES; ++i) {
+        t[i] = state_time_ms[i] / 1000.0;
+        if (i == power_state) t[i] += (now - state_since_ms) / 1000.0;
+    }
+    char json[512];
+    snprintf(json, sizeof(json),
+             "{\"power\": {\"state\": \"%s\", \"poll_hz\": %.2f, \"time_s\": "
+             "{\"running\": %.1f, \"idling\": %.1f, \"engine_off\": %.1f, \"adapter_asleep\": %.1f}}}",
+             state_names[power_state], poll_hz,
+             t[ST_RUNNING], t[ST_IDLING], t[ST_ENGINE_OFF], t[ST_ADAPTER_ASLEEP]);
+
+    pthread_mutex_lock(&pending_mutex);
+    strncpy(pending_power_msg, json, sizeof(pending_power_msg)-1);
+    pending_power_msg[sizeof(pending_power_msg)-1] = '\0';
+    pending_power_flag = 1;
+    pthread_mutex_unlock(&pending_mutex);
+}
+
+// expected poll rate of a schedule, in commands per second
+static double schedule_poll_hz(int state) {
+    const struct poll_schedule *sch = &schedules[state];
+    int n = sch->n_polled ? sch->n_polled : n_pids;
+    return n * 1000.0 / (n * sch->cmd_gap_ms + sch->cycle_gap_ms);
+}
+
+// (caller holds power_mutex)
+static void power_set_state_locked(int state) {
+    if (state == power_state) return;
+    uint64_t now = now_ms();
+    state_time_ms[power_state] += now - state_since_ms;
+    fprintf(stderr, "[power] %s -> %s (poll %.2f Hz)\n",
+            state_names[power_state], state_names[state], schedule_poll_hz(state));
+    power_state = state;
+    state_since_ms = now;
+    // values from before the adapter went silent are stale
+    if (state == ST_ADAPTER_ASLEEP) last_rpm = last_speed = -1;
+    power_publish_locked(now, schedule_poll_hz(state));
+    pthread_cond_broadcast(&power_cond);
+}
+
+// feed a decoded OBD sample into the state machine
+static void power_on_sample(int ch, double value) {
+    pthread_mutex_lock(&power_mutex);
+    last_response_ms = now_ms();
+    if (ch == CH_RPM) last_rpm = (int)value;
+    if (ch == CH_SPEED) last_speed = (int)value;
+
+    int state = power_state;
+    if (last_speed > 0) state = ST_RUNNING;   // moving, even with the engine stopped (hybrid, stall)
+    else if (last_rpm > 0) state = last_speed == 0 ? ST_IDLING : ST_RUNNING;
+    else if (last_rpm == 0 && last_speed == 0) state = ST_ENGINE_OFF;
+    else if (state == ST_ADAPTER_ASLEEP)      // responding again, speed/rpm not known yet
+        state = last_rpm == 0 ? ST_ENGINE_OFF : ST_RUNNING;
+    power_set_state_locked(state);
+    pthread_mutex_unlock(&power_mutex);
+}
+
+static void power_check_asleep(void) {
+    pthread_mutex_lock(&power_mutex);
+    if (now_ms() - last_response_ms > ASLEEP_TIMEOUT_MS)
+        power_set_state_locked(ST_ADAPTER_ASLEEP);
+    pthread_mutex_unlock(&power_mutex);
+}
+
+// sleep up to 'ms'; returns 1 early if the state changed from 'state' (or on shutdown)
+static int power_wait(int ms, int state) {
+    struct timespec ts;
+    clock_gettime(CLOCK_REALTIME, &ts);
+    ts.tv_sec += ms / 1000;
+    ts.tv_nsec += (long)(ms % 1000) * 1000000L;
+    if (ts.tv_nsec >= 1000000000L) {
+        ts.tv_sec++;
+        ts.tv_nsec -= 1000000000L;
+    }
+    int changed = 0;
+    pthread_mutex_lock(&power_mutex);
+    while (running && power_state == state) {
+        if (pthread_cond_timedwait(&power_cond, &power_mutex, &ts) != 0) break;
+    }
+    changed = !running || power_state != state;
+    pthread_mutex_unlock(&power_mutex);
+    return changed;
+}
+
 // helper: hex-encode ascii string (e.g. "010C\r\n" -> "303130430d0a")
 static void ascii_to_hexstr_crlf(const char *ascii, char *out_hex, size_t out_len) {
     size_t p = 0;
@@ -84,10 +344,19 @@ static int enable_notify() {
 }
 
 // thread: writer -> polls PIDs periodically and writes them (CRLF terminated)
+// The schedule follows the power state; a state change interrupts the pauses
+// so waking up takes effect immediately.
 static void *writer_thread(void *arg) {
     (void)arg;
     while (running) {
-        for (int i = 0; i < n_pids && running; ++i) {
+        pthread_mutex_lock(&power_mutex);
+        int state = power_state;
+        pthread_mutex_unlock(&power_mutex);
+        const struct poll_schedule *sch = &schedules[state];
+        int n = sch->n_polled ? sch->n_polled : n_pids;
+
+        int changed = 0;
+        for (int i = 0; i < n && running && !changed; ++i) {
             char hexpayload[128];
             build_cmd_hex(pids[i], hexpayload, sizeof(hexpayload));
             // send to write handle
@@ -96,11 +365,15 @@ static void *writer_thread(void *arg) {
                 // try reconnect briefly: a simple ping connect via char-write to notify descriptor
                 enable_notify();
             }
+            pthread_mutex_lock(&power_mutex);
+            polls_sent++;
+            pthread_mutex_unlock(&power_mutex);
             // small pause between writes - adapt to reduce bus saturation
-            usleep(200000); // 200 ms between commands
+            changed = power_wait(sch->cmd_gap_ms, state);
         }
         // small pause between cycles
-        usleep(200000); // additional 200 ms -> ~ (n_pids*0.2 + 0.2) seconds per cycle
+        if (!changed) power_wait(sch->cycle_gap_ms, state);
+        power_check_asleep();
     }
     return NULL;
 }
@@ -114,35 +387,46 @@ static void process_obd_tokens(const unsigned char *bytes, int count) {
         if (i + 1 >= count) continue;
         unsigned int pid = bytes[i+1];
         char json[256];
+        int ch;
+        double value;
         if (pid == 0x0C && i + 3 < count) {
             // RPM
             int A = bytes[i+2];
             int B = bytes[i+3];
             int rpm = ((A * 256) + B) / 4;
             snprintf(json, sizeof(json), "{\"rpm\": %d}", rpm);
+            ch = CH_RPM; value = rpm;
         } else if (pid == 0x0D && i + 2 < count) {
             int A = bytes[i+2];
             snprintf(json, sizeof(json), "{\"speed\": %d}", A);
+            ch = CH_SPEED; value = A;
         } else if (pid == 0x11 && i + 2 < count) {
             int A = bytes[i+2];
             double tps = (A * 100.0) / 255.0;
             snprintf(json, sizeof(json), "{\"tps\": %.1f}", tps);
+            ch = CH_TPS; value = tps;
         } else if (pid == 0x0B && i + 2 < count) {
             int A = bytes[i+2];
             snprintf(json, sizeof(json), "{\"map\": %d}", A);
+            ch = CH_MAP; value = A;
         } else if (pid == 0x05 && i + 2 < count) {
             int A = bytes[i+2];
             int temp = A - 40;
             snprintf(json, sizeof(json), "{\"coolant\": %d}", temp);
+            ch = CH_COOLANT; value = temp;
         } else if (pid == 0x42 && i + 3 < count) {
             int A = bytes[i+2];
             int B = bytes[i+3];
             double battery = ((A * 256) + B) / 1000.0;
             snprintf(json, sizeof(json), "{\"battery\": %.3f}", battery);
+            ch = CH_BATTERY; value = battery;
         } else {
             continue;
         }
 
+        history_push(ch, now_ms(), value);
+        power_on_sample(ch, value);
+
         // publish pending message (thread-safe)
         pthread_mutex_lock(&pending_mutex);
         strncpy(pending_msg, json, sizeof(pending_msg)-1);
@@ -246,25 +530,93 @@ static void *listener_thread(void *arg) {
     return NULL;
 }
 
+// HTTP: GET /history?ch=rpm&from=<ms>&to=<ms>&points=<n>
+// from/to are epoch milliseconds (default: last 10 minutes), points is the
+// number of min/max/avg buckets to return (default 300).
+static int serve_history(struct lws *wsi, const char *uri) {
+    if (strcmp(uri, "/history") != 0) {
+        lws_return_http_status(wsi, HTTP_STATUS_NOT_FOUND, NULL);
+        return -1;
+    }
+
+    char arg[64];
+    const char *v;
+    int ch = -1;
+    if ((v = lws_get_urlarg_by_name(wsi, "ch=", arg, sizeof(arg))))
+        ch = history_channel_by_name(v);
+    if (ch < 0) {
+        lws_return_http_status(wsi, HTTP_STATUS_BAD_REQUEST, "unknown channel");
+        return -1;
+    }
+
+    uint64_t to_ms = now_ms();
+    if ((v = lws_get_urlarg_by_name(wsi, "to=", arg, sizeof(arg))))
+        to_ms = strtoull(v, NULL, 10);
+    uint64_t from_ms = to_ms > HISTORY_DEFAULT_SPAN_MS ? to_ms - HISTORY_DEFAULT_SPAN_MS : 0;
+    if ((v = lws_get_urlarg_by_name(wsi, "from=", arg, sizeof(arg))))
+        from_ms = strtoull(v, NULL, 10);
+    int points = HISTORY_DEFAULT_POINTS;
+    if ((v = lws_get_urlarg_by_name(wsi, "points=", arg, sizeof(arg))))
+        points = atoi(v);
+    if (points < 1) points = 1;
+    if (points > HISTORY_MAX_POINTS) points = HISTORY_MAX_POINTS;
+    if (from_ms > to_ms) {
+        lws_return_http_status(wsi, HTTP_STATUS_BAD_REQUEST, "from > to");
+        return -1;
+    }
+
+    // ~80 bytes per bucket is enough for the widest values we produce
+    size_t body_cap = 256 + (size_t)points * 80;
+    unsigned char *body = malloc(LWS_PRE + body_cap);
+    if (!body) return -1;
+    int body_len = history_query_json(ch, from_ms, to_ms, points,
+                                      (char *)&body[LWS_PRE], body_cap);
+    if (body_len < 0) {
+        free(body);
+        lws_return_http_status(wsi, HTTP_STATUS_INTERNAL_SERVER_ERROR, NULL);
+        return -1;
+    }
+
+    unsigned char hdr[LWS_PRE + 512];
+    unsigned char *start = &hdr[LWS_PRE], *p = start, *end = &hdr[sizeof(hdr) - 1];
+    if (lws_add_http_common_headers(wsi, HTTP_STATUS_OK, "application/json",
+                                    (lws_filepos_t)body_len, &p, end) ||
+        lws_finalize_write_http_header(wsi, start, &p, end)) {
+        free(body);
+        return -1;
+    }
+    lws_write(wsi, &body[LWS_PRE], (size_t)body_len, LWS_WRITE_HTTP_FINAL);
+    free(body);
+    return lws_http_transaction_completed(wsi) ? -1 : 0;
+}
+
 // WebSocket callback (protocol)
 static int ws_callback(struct lws *wsi, enum lws_callback_reasons reason,
                        void *user, void *in, size_t len) {
-    (void)user; (void)in; (void)len;
+    (void)user; (void)len;
     switch (reason) {
+        case LWS_CALLBACK_HTTP:
+            return serve_history(wsi, (const char *)in);
         case LWS_CALLBACK_ESTABLISHED:
             lwsl_notice("Client connected\n");
             break;
         case LWS_CALLBACK_SERVER_WRITEABLE: {
-            // if pending message available, send it
+            // if pending message available, send it (power state first, one per callback)
             pthread_mutex_lock(&pending_mutex);
-            int have = pending_flag;
+            int have = pending_power_flag || pending_flag;
             char msg[512];
-            if (have) {
+            if (pending_power_flag) {
+                strncpy(msg, pending_power_msg, sizeof(msg)-1);
+                msg[sizeof(msg)-1] = '\0';
+                pending_power_flag = 0;
+            } else if (pending_flag) {
                 strncpy(msg, pending_msg, sizeof(msg)-1);
                 msg[sizeof(msg)-1] = '\0';
                 pending_flag = 0;
             }
+            int more = pending_flag;
             pthread_mutex_unlock(&pending_mutex);
+            if (more) lws_callback_on_writable(wsi);
 
             if (have) {
                 // send as text
@@ -315,6 +667,8 @@ int main(int argc, char **argv) {
     }
     usleep(200000);
 
+    state_since_ms = last_response_ms = now_ms();
+
     // 2) Start listener thread (gatttool --listen)
     pthread_t tid_listen, tid_write;
     if (pthread_create(&tid_listen, NULL, listener_thread, NULL) != 0) {
@@ -343,13 +697,32 @@ int main(int argc, char **argv) {
     }
 
     // 5) main loop
+    uint64_t last_report = now_ms();
+    unsigned long last_polls = 0;
     while (running) {
         if (ws_context) lws_service(ws_context, 50);
         // wake all writable to push any pending messages
         if (ws_context) lws_callback_on_writable_all_protocol(ws_context, &protocols[0]);
         usleep(20000);
+
+        // periodic power report: state, measured poll rate, time per state
+        uint64_t now = now_ms();
+        if (now - last_report >= POWER_REPORT_MS) {
+            pthread_mutex_lock(&power_mutex);
+            double poll_hz = (polls_sent - last_polls) * 1000.0 / (now - last_report);
+            last_polls = polls_sent;
+            fprintf(stderr, "[power] state=%s poll=%.2f Hz\n", state_names[power_state], poll_hz);
+            power_publish_locked(now, poll_hz);
+            pthread_mutex_unlock(&power_mutex);
+            last_report = now;
+        }
     }
 
+    // wake the writer out of a heartbeat pause
+    pthread_mutex_lock(&power_mutex);
+    pthread_cond_broadcast(&power_cond);
+    pthread_mutex_unlock(&power_mutex);
+
     // cleanup
     if (ws_context) lws_context_destroy(ws_context);
     pthread_join(tid_write, NULL);